@@ -14,6 +14,8 @@
 
 #define STRASSEN_POWER 6
 #define LARGEMATRIXFORSTRASSEN 1 << STRASSEN_POWER
+
+#define PARALLELCLONE 4096
 using namespace std;
 
 // https://cs.stackexchange.com/questions/92666/strassen-algorithm-for-unusal-matrices
@@ -22,9 +24,32 @@ using namespace std;
 
 class Matrix {
     private:
-        std::unique_ptr<double[]> mat;
+        // shared between copies, cloned on the first write (copy-on-write)
+        std::shared_ptr<double> mat;
         bool data_is_transposed = false;
 
+        static std::shared_ptr<double> share(std::unique_ptr<double[]> buffer) {
+            return std::shared_ptr<double>(buffer.release(), std::default_delete<double[]>());
+        }
+
+        // gives this matrix its own buffer before a write if the current one is shared
+        // use_count is only approximate while other threads copy this matrix, writes come from python under the GIL
+        void detach() {
+            if (this->mat.use_count() <= 1) {
+                return;
+            }
+            const long entries = rows * cols;
+            unique_ptr<double[]> cloned = std::make_unique<double[]>(entries);
+            const double* src = this->mat.get();
+            double* dst = cloned.get();
+
+            #pragma omp parallel for simd if(entries > PARALLELCLONE)
+            for (long i = 0; i < entries; ++i) {
+                dst[i] = src[i];
+            }
+            this->mat = Matrix::share(std::move(cloned));
+        }
+
         bool is_transposed() const {
             return this->data_is_transposed;
         }
@@ -41,26 +66,26 @@ class Matrix {
             return length << count;
         }
 
-        // used to skip transpose checks i.e. matrix just created.
+        // used to skip transpose checks i.e. matrix just created, so never shared either.
         void set_item_inner_assume_no_t(size_t r, size_t c, double value) {
-            this->mat[r * cols + c] = value;
+            this->mat.get()[r * cols + c] = value;
         }
 
         double get_item_inner(size_t r, size_t c) const {
 
             if (this->data_is_transposed) { // reduce overhead
-                return mat[c * rows + r];
+                return mat.get()[c * rows + r];
             } else {
-                return mat[r * cols + c];
+                return mat.get()[r * cols + c];
             }
         }
 
         void set_item_inner(size_t r, size_t c, double value) {
 
             if (this->data_is_transposed) { // reduce overhead
-                this->mat[c * rows + r] = value;
+                this->mat.get()[c * rows + r] = value;
             } else {
-                this->mat[r * cols + c] = value;
+                this->mat.get()[r * cols + c] = value;
             }
         }
 
@@ -74,25 +99,23 @@ class Matrix {
         if (rows <= 0 || cols <= 0) {
             throw std::out_of_range("Matrix dimensions must be positive");
         }
-        mat = std::make_unique<double[]>(rows * cols);
+        mat = Matrix::share(std::make_unique<double[]>(rows * cols));
     }
 
-    Matrix(const size_t rows, const size_t cols, std::unique_ptr<double[]> mat) : rows(rows), cols(cols), mat(std::move(mat)) {
+    Matrix(const size_t rows, const size_t cols, std::unique_ptr<double[]> mat) : rows(rows), cols(cols), mat(Matrix::share(std::move(mat))) {
         if (rows <= 0 || cols <= 0) {
             throw std::out_of_range("Matrix dimensions must be positive");
         }
     }
 
-    // copy constructor
-    Matrix(const Matrix& other) : rows(other.rows), cols(other.cols) {
-        mat = std::make_unique<double[]>(rows * cols);
-
-        //#pragma omp parallel for
-        for (long i = 0; i < rows * cols; ++i) mat[i] = other.mat[i];
-
+    // copy constructor, O(1): shares the buffer until either side writes
+    Matrix(const Matrix& other) : mat(other.mat), rows(other.rows), cols(other.cols) {
         this->data_is_transposed = other.is_transposed();
     }
 
+    // move constructor, lets intermediates hand over their buffers instead of deep copying
+    Matrix(Matrix&& other) = default;
+
     template <typename T>
     Matrix(const T& list);
 
@@ -132,18 +155,19 @@ class Matrix {
         return std::vector<double>(this->mat.get(), this->mat.get() + size);
     }
 
-    // probably not needed for insanely large matrices
+    // shares the buffer like the copy constructor
     Matrix& operator=(const Matrix& other) {
         if (this != &other) {
             this->rows = other.rows;
             this->cols = other.cols;
             this->data_is_transposed = other.is_transposed();
-            this->mat = std::make_unique<double[]>(other.rows * other.cols);
-            for (size_t i = 0; i < rows * cols; ++i) this->mat[i] = other.mat[i];
+            this->mat = other.mat;
             return *this;
         }
         return *this;
     }
+
+    Matrix& operator=(Matrix&& other) = default;
     
     std::tuple<size_t, size_t> get_dims() const {
         return std::make_tuple(this->rows, this->cols);
@@ -167,10 +191,12 @@ class Matrix {
             throw std::out_of_range("Matrix index out of bounds");
         }
 
+        this->detach();
         this->set_item_inner(r, c, value);
     }
 
 
+    // O(1), the buffer is only cloned once either matrix is written to
     Matrix copy() {
         return Matrix(*this);
     }
@@ -268,7 +294,7 @@ class Matrix {
         unique_ptr<double[]> new_mat = std::make_unique<double[]>(entries);
         for (size_t i = 0; i < entries; ++i) {
             // matrices guaranteed to not be transposed due to padding
-            new_mat[i] = curr.mat[i] + other.mat[i];
+            new_mat[i] = curr.mat.get()[i] + other.mat.get()[i];
         }
         return Matrix(rows, cols, std::move(new_mat));
     }
@@ -322,7 +348,7 @@ class Matrix {
         unique_ptr<double[]> new_mat = std::make_unique<double[]>(entries);
  
         for (size_t i = 0; i < entries; ++i) {
-            new_mat[i] = curr.mat[i] - other.mat[i];
+            new_mat[i] = curr.mat.get()[i] - other.mat.get()[i];
         }
         return Matrix(rows, cols, std::move(new_mat));
     }
@@ -450,10 +476,10 @@ class Matrix {
                 value1 = i * padded.cols + j;
                 value2 = (i + length) * padded.cols + j;
                 // due to padding from strassens, matrix is guaranteed to not be transposed
-                mat_1[location] = padded.mat[value1];
-                mat_2[location] = padded.mat[value1 + length];
-                mat_3[location] = padded.mat[value2];
-                mat_4[location] = padded.mat[value2 + length];
+                mat_1[location] = padded.mat.get()[value1];
+                mat_2[location] = padded.mat.get()[value1 + length];
+                mat_3[location] = padded.mat.get()[value2];
+                mat_4[location] = padded.mat.get()[value2 + length];
             }
         }
 
@@ -476,13 +502,13 @@ class Matrix {
         for (long r = 0; r < desired; ++r) {
             for (long c = 0; c < desired; ++c) {
                 if (r < length && c < length) {
-                    combined[r * desired + c] = C11.mat[r * length + c];
+                    combined[r * desired + c] = C11.mat.get()[r * length + c];
                 } else if (r < length) {
-                    combined[r * desired + c] = C12.mat[r * length + c - length];
+                    combined[r * desired + c] = C12.mat.get()[r * length + c - length];
                 } else if (c < length) {
-                    combined[r * desired + c] = C21.mat[(r - length) * length + c];
+                    combined[r * desired + c] = C21.mat.get()[(r - length) * length + c];
                 } else {
-                    combined[r * desired + c] = C22.mat[(r - length) * length + c - length];
+                    combined[r * desired + c] = C22.mat.get()[(r - length) * length + c - length];
                 }
             }
         }
@@ -572,7 +598,7 @@ class Matrix {
             for (long e = 0; e < this->rows * other.cols; ++e) {
                 long i = e / other.cols;
                 long j = e % other.cols;
-                unpadded[i * other.cols + j] = padded_result.mat[i * padded_result.cols + j]; //guaranteed untransposed
+                unpadded[i * other.cols + j] = padded_result.mat.get()[i * padded_result.cols + j]; //guaranteed untransposed
             }
 
             return Matrix(this->rows, other.cols, std::move(unpadded));
@@ -580,6 +606,125 @@ class Matrix {
         
     }
 
+    // estimated flops of strassen() on a padded length x length matrix, mirrors its recursion
+    static double strassen_cost(size_t length) {
+        if (length < LARGEMATRIXFORSTRASSEN) {
+            return (double) length * length * length;
+        }
+        double half = (double) (length >> 1);
+        // 7 sub-products, 18 quadrant adds/subs, 8 quadrant copies and the combine
+        return 7 * Matrix::strassen_cost(length >> 1) + 30 * half * half;
+    }
+
+    // estimated flops of mat_mul() for (p x q) @ (q x r), using the same crossover and padding
+    static double mat_mul_cost(size_t p, size_t q, size_t r) {
+        if (q < LARGEMATRIXFORSTRASSEN || p < LARGEMATRIXFORSTRASSEN || r < LARGEMATRIXFORSTRASSEN) {
+            return (double) p * q * r;
+        }
+        double padded = (double) Matrix::get_2n(std::max(std::max(q, p), r));
+        // pad both operands and strip the padding off the result
+        return Matrix::strassen_cost((size_t) padded) + 3 * padded * padded;
+    }
+
+    // computes chain[i..k] and chain[k+1..j] as two omp tasks, must be called inside a parallel region
+    static void multi_dot_halves(const std::vector<Matrix>& chain, const std::vector<std::vector<size_t>>& splits, size_t i, size_t k, size_t j, Matrix& left, Matrix& right) {
+        #pragma omp task shared(left, chain, splits)
+        left = Matrix::multi_dot_inner(chain, splits, i, k);
+
+        #pragma omp task shared(right, chain, splits)
+        right = Matrix::multi_dot_inner(chain, splits, k + 1, j);
+
+        #pragma omp taskwait
+    }
+
+    // true if any product of chain[i..j] in the chosen order goes through strassen, same check as mat_mul
+    static bool multi_dot_uses_strassen(const std::vector<Matrix>& chain, const std::vector<std::vector<size_t>>& splits, size_t i, size_t j) {
+        if (i == j) {
+            return false;
+        }
+        const size_t k = splits[i][j];
+        if (chain[i].rows >= LARGEMATRIXFORSTRASSEN && chain[k].cols >= LARGEMATRIXFORSTRASSEN && chain[j].cols >= LARGEMATRIXFORSTRASSEN) {
+            return true;
+        }
+        return Matrix::multi_dot_uses_strassen(chain, splits, i, k) || Matrix::multi_dot_uses_strassen(chain, splits, k + 1, j);
+    }
+
+    // evaluates chain[i..j] (j > i) following the split table
+    // inside a task strassen's own parallel region would get a team of 1 (max_active_levels defaults to 1),
+    // so halves only run as concurrent tasks when both are serial mat_mul_default products,
+    // otherwise they run one after the other and each strassen gets the full team
+    static Matrix multi_dot_inner(const std::vector<Matrix>& chain, const std::vector<std::vector<size_t>>& splits, size_t i, size_t j) {
+        const size_t k = splits[i][j];
+        const bool left_is_product = k > i;
+        const bool right_is_product = j > k + 1;
+        Matrix left, right;
+
+        if (left_is_product && right_is_product
+            && !Matrix::multi_dot_uses_strassen(chain, splits, i, k)
+            && !Matrix::multi_dot_uses_strassen(chain, splits, k + 1, j)) {
+            if (omp_in_parallel()) {
+                Matrix::multi_dot_halves(chain, splits, i, k, j, left, right);
+            } else {
+                #pragma omp parallel
+                {
+                    #pragma omp single
+                    {
+                        Matrix::multi_dot_halves(chain, splits, i, k, j, left, right);
+                    }
+                }
+            }
+        } else {
+            if (left_is_product) left = Matrix::multi_dot_inner(chain, splits, i, k);
+            if (right_is_product) right = Matrix::multi_dot_inner(chain, splits, k + 1, j);
+        }
+
+        // leaves are used in place rather than copied
+        const Matrix& lhs = left_is_product ? left : chain[i];
+        const Matrix& rhs = right_is_product ? right : chain[j];
+        return lhs.mat_mul(rhs);
+    }
+
+    // multiplies a chain of matrices in the cheapest order (matrix chain dp)
+    static Matrix multi_dot(const std::vector<Matrix>& chain) {
+        const size_t n = chain.size();
+        if (n == 0) {
+            throw std::runtime_error("Matrix chain must be nonempty");
+        }
+        for (size_t i = 1; i < n; ++i) {
+            if (chain[i - 1].cols != chain[i].rows) {
+                throw std::runtime_error(
+                    "Dimensions of " + std::to_string(chain[i - 1].cols) + " and " + std::to_string(chain[i].rows) +  " do not match"
+                );
+            }
+        }
+        if (n == 1) {
+            return chain[0];
+        }
+
+        // dims[i] x dims[i + 1] is the shape of chain[i]
+        std::vector<size_t> dims(n + 1);
+        dims[0] = chain[0].rows;
+        for (size_t i = 0; i < n; ++i) dims[i + 1] = chain[i].cols;
+
+        std::vector<std::vector<double>> cost(n, std::vector<double>(n, 0));
+        std::vector<std::vector<size_t>> splits(n, std::vector<size_t>(n, 0));
+        for (size_t len = 1; len < n; ++len) {
+            for (size_t i = 0; i + len < n; ++i) {
+                const size_t j = i + len;
+                cost[i][j] = -1;
+                for (size_t k = i; k < j; ++k) {
+                    double candidate = cost[i][k] + cost[k + 1][j] + Matrix::mat_mul_cost(dims[i], dims[k + 1], dims[j + 1]);
+                    if (cost[i][j] < 0 || candidate < cost[i][j]) {
+                        cost[i][j] = candidate;
+                        splits[i][j] = k;
+                    }
+                }
+            }
+        }
+
+        return Matrix::multi_dot_inner(chain, splits, 0, n - 1);
+    }
+
     Matrix pow(long number) {
         if (this->cols != this->rows) {
             throw std::runtime_error("Matrix must be square");
@@ -30,7 +30,7 @@ Matrix::Matrix(const T& list) {
 
     auto first_cast = matrix_cast[0];
     this->cols = first_cast.size();
-    this->mat = make_unique<double[]>(rows * cols);
+    this->mat = Matrix::share(make_unique<double[]>(rows * cols));
     // copy first row in
     std::copy(first_cast.begin(), first_cast.end(), this->mat.get());
 
@@ -48,11 +48,12 @@ Matrix::Matrix(const T& list) {
 PYBIND11_MODULE(matmul, m) {
     m.doc() = "A fun module I built while learning cpp, wip"; // still in the works
     //m.def("add", &add, "A function that adds two numbers");
+    m.def("multi_dot", &Matrix::multi_dot, "Multiplies a chain of matrices in the cheapest order");
 
     py::class_<Matrix>(m, "Matrix")
         .def(py::init<const py::list&>())
         .def(py::init<const py::tuple&>())
-        .def("assign", &Matrix::operator=)
+        .def("assign", py::overload_cast<const Matrix&>(&Matrix::operator=))
         .def("T", &Matrix::transpose)
         .def("copy", &Matrix::copy)
         .def("__repr__", &Matrix::repr)
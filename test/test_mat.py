@@ -2,7 +2,7 @@ import pytest
 import random
 import copy
 import numpy as np
-from matmul import Matrix
+from matmul import Matrix, multi_dot
 
 @pytest.fixture(scope="function")
 def setup_mats():
@@ -73,6 +73,23 @@ def test_insert(setup_mats):
     assert (E.copy().T() - D.copy().T()).T() == C
     
 
+def test_copy_on_write(setup_mats):
+    B = setup_mats["mat_B"]
+    C = setup_mats["mat_C"]
+    A = B.copy()
+    D = Matrix([[0]])
+    D.assign(B)
+    P = B ** 1
+    A[0, 0] = 100
+    assert A[0, 0] == 100
+    assert B == C == D == P
+    T = B.copy().T()
+    T[1, 0] = -1
+    assert T[1, 0] == -1 and B[0, 1] == C[0, 1]
+    B[1, 1] = 0
+    assert D == P == C and B != C
+    
+
 def test_empty(setup_mats):
     with pytest.raises(RuntimeError, match="Matrix must be nonempty"):
         Matrix([])
@@ -139,5 +156,33 @@ def test_generic(setup_mats):
             i, j = random.randint(0, size - 1), random.randint(0, size - 1)
             assert (A @ B.T())[i, j] == (NA @ NB.T)[i, j]
 
-    
-
+def test_multi_dot(setup_mats):
+    E = setup_mats["mat_E"]
+    I = setup_mats["mat_I"]
+    assert multi_dot([E]) == E
+    assert multi_dot([E, I, E.copy().T()]) == E @ I @ E.copy().T()
+    with pytest.raises(RuntimeError, match="Matrix chain must be nonempty"):
+        multi_dot([])
+    with pytest.raises(RuntimeError, match="do not match"):
+        multi_dot([E, setup_mats["vec_A"]])
+
+    shapes = [(300, 10), (10, 200), (200, 70), (70, 130), (130, 1)]
+    lsofls = [[[random.randint(-3, 3) for _ in range(c)] for _ in range(r)] for r, c in shapes]
+    chain = [Matrix(ls) for ls in lsofls]
+    expected = np.linalg.multi_dot([np.array(ls) for ls in lsofls])
+    result = multi_dot(chain)
+    assert result.dims() == (300, 1)
+    for i in range(300):
+        assert result[i, 0] == expected[i, 0]
+
+def test_multi_dot_strassen(setup_mats):
+    H = setup_mats["mat_H"]
+    assert multi_dot([H, H, H]) == H @ H @ H
+    # every product here is at least 64 in each dimension, so the chosen order goes through strassen
+    shapes = [(200, 64), (64, 150), (150, 80), (80, 128)]
+    chain = [Matrix([[random.randint(-3, 3) for _ in range(c)] for _ in range(r)]) for r, c in shapes]
+    expected = chain[0] @ chain[1] @ chain[2] @ chain[3]
+    result = multi_dot(chain)
+    assert result.dims() == (200, 128)
+    assert result == expected
+    assert multi_dot(chain + [H]) == expected @ H